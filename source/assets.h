@@ -0,0 +1,64 @@
+/*  Full Screen Bitmap Assets
+
+    PNGs in graphics/ are converted by grit at build time into LZ77
+    compressed 16bpp bitmaps (see the .grit files). loadScreen() has the
+    BIOS decompress one straight into VRAM, no buffer needed. Load time
+    and compression ratio are recorded for each asset and written to the
+    event trace.
+*/
+
+#include "title_screen.h"
+#include "menu_screen.h"
+#include "win_screen.h"
+
+enum screenAsset
+{
+    ASSET_TITLE,
+    ASSET_MENU,
+    ASSET_WIN,
+    ASSET_COUNT
+};
+
+typedef struct
+{
+    const unsigned int *data;
+    int compressedBytes;
+} bitmapAsset;
+
+const bitmapAsset screenAssets[ASSET_COUNT] = {
+    {title_screenBitmap, title_screenBitmapLen},
+    {menu_screenBitmap, menu_screenBitmapLen},
+    {win_screenBitmap, win_screenBitmapLen},
+};
+
+typedef struct
+{
+    int compressedBytes;
+    int rawBytes;
+    int ratioPercent; // Compressed size as a percentage of raw
+    u32 loadCycles;   // Last load, measured with the cycle timer
+} assetStats;
+
+assetStats screenAssetStats[ASSET_COUNT];
+
+/* Decompress a full screen bitmap into the mode 3 framebuffer */
+void loadScreen(int asset)
+{
+    const bitmapAsset *bitmap = &screenAssets[asset];
+    assetStats *stats = &screenAssetStats[asset];
+
+    startCycleTimer();
+    LZ77UnCompVram((void *)bitmap->data, (void *)MEM_VRAM);
+    stats->loadCycles = stopCycleTimer();
+
+    /* LZ77 header: type in the low byte, decompressed size above it */
+    stats->compressedBytes = bitmap->compressedBytes;
+    stats->rawBytes = bitmap->data[0] >> 8;
+    stats->ratioPercent = stats->compressedBytes * 100 / stats->rawBytes;
+
+    TRACE(TRACE_ASSET_LOAD, asset, stats->loadCycles >> 8);
+    TRACE(TRACE_ASSET_SIZE, asset, stats->ratioPercent);
+
+    /* Loading blocks for a few frames, don't count them as overruns */
+    schedulerResync();
+}
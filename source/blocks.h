@@ -0,0 +1,269 @@
+/*  Obstacle Mode Blocks
+
+    Breakout style blocks fill the middle of the court, with a clear lane
+    down the centre line for the serve. Block positions are fixed by their
+    index, so only the alive bits (kept in the game state arena) change
+    during a match.
+
+    Collision uses a uniform grid broadphase: each 16x16 cell lists the
+    blocks inside it, and the ball only tests blocks in the cells it
+    overlaps. A destroyed block queues a clear of just its own rectangle.
+    Blocks brought back by a rewind are only marked, and repainted once
+    the frame's sprite clears are queued so those can't erase them.
+*/
+
+#define BLOCK_WIDTH 8
+#define BLOCK_HEIGHT 4
+
+/* Block area is 14 columns wide, the middle two are left empty for the lane.
+   It starts below the scores, which are redrawn every frame, on a cell boundary. */
+#define BLOCK_AREA_X 64
+#define BLOCK_AREA_Y 32
+#define BLOCK_LANE_COL 6
+#define BLOCK_LANE_COLS 2
+
+#define CELL_SIZE 16
+#define GRID_COLS (SCREEN_WIDTH / CELL_SIZE)
+#define GRID_ROWS (SCREEN_HEIGHT / CELL_SIZE)
+#define CELL_CAPACITY 8
+
+_Static_assert(BLOCK_AREA_Y >= SCORE_Y + 2 * CHAR_PIX_SIZE, "blocks overlap the scores");
+_Static_assert(BLOCK_AREA_Y + BLOCK_ROWS * BLOCK_HEIGHT <= SCREEN_HEIGHT, "blocks run off the screen");
+
+typedef struct
+{
+    u16 blocks[CELL_CAPACITY];
+    u8 count;
+} gridCell;
+
+typedef struct
+{
+    gridCell cells[GRID_ROWS][GRID_COLS];
+
+    /* Counters, for using obstacle mode as a collision benchmark */
+    int blockTests;     // Narrow phase tests in the last step
+    int maxBlockTests;
+    int blocksDestroyed;
+    int cellOverflow;   // Blocks that didn't fit in a grid cell
+
+    /* Blocks whose alive bit changed since they were last drawn */
+    u32 redrawPending[BLOCK_WORDS];
+} blockField;
+
+blockField blockGrid;
+
+/* Position of a block from its index */
+void blockPosition(int index, int *x, int *y)
+{
+    int col = index % BLOCK_COLS;
+    int row = index / BLOCK_COLS;
+
+    if (col >= BLOCK_LANE_COL)
+        col += BLOCK_LANE_COLS;
+
+    *x = BLOCK_AREA_X + col * BLOCK_WIDTH;
+    *y = BLOCK_AREA_Y + row * BLOCK_HEIGHT;
+}
+
+bool isBlockAlive(int index)
+{
+    return game.blockAlive[index / 32] & (1u << (index % 32));
+}
+
+/* Rows are banded in a few colours */
+int blockColor(int index)
+{
+    const int colors[4] = {CLR_RED, CLR_YELLOW, CLR_CYAN, CLR_MAG};
+    return colors[(index / BLOCK_COLS / 8) % 4];
+}
+
+/* Add a block to every grid cell its rectangle touches */
+void insertBlock(int index)
+{
+    int x, y;
+    blockPosition(index, &x, &y);
+
+    for (int cy = y / CELL_SIZE; cy <= (y + BLOCK_HEIGHT - 1) / CELL_SIZE; cy++)
+    {
+        for (int cx = x / CELL_SIZE; cx <= (x + BLOCK_WIDTH - 1) / CELL_SIZE; cx++)
+        {
+            gridCell *cell = &blockGrid.cells[cy][cx];
+
+            if (cell->count >= CELL_CAPACITY)
+            {
+                blockGrid.cellOverflow++;
+                continue;
+            }
+
+            cell->blocks[cell->count++] = index;
+        }
+    }
+}
+
+/* Build the grid once at boot, the layout never changes */
+void buildBlockGrid()
+{
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        insertBlock(i);
+    }
+}
+
+/* Queue a redraw of one block, leaving a one pixel gap around it */
+void queueBlock(int index)
+{
+    int x, y;
+    blockPosition(index, &x, &y);
+
+    queueFill(x, y, BLOCK_WIDTH - 1, BLOCK_HEIGHT - 1, blockColor(index));
+}
+
+/* Draw the full block set straight to VRAM, only when a match starts */
+void drawBlocks()
+{
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        if (!isBlockAlive(i))
+            continue;
+
+        int x, y;
+        blockPosition(i, &x, &y);
+
+        /* Leave a one pixel gap between blocks */
+        rectangle block = {x, y, x, y, BLOCK_WIDTH - 1, BLOCK_HEIGHT - 1};
+        drawRectangle(&block, blockColor(i));
+    }
+}
+
+void destroyBlock(int index)
+{
+    int x, y;
+    blockPosition(index, &x, &y);
+
+    game.blockAlive[index / 32] &= ~(1u << (index % 32));
+    game.blocksRemaining--;
+    blockGrid.blocksDestroyed++;
+    TRACE(TRACE_BLOCK_HIT, 0, index);
+
+    /* Localised clear instead of a redraw */
+    queueClearRegion(x, y, x + BLOCK_WIDTH, y + BLOCK_HEIGHT);
+}
+
+/*  Destroy any blocks the ball overlaps and bounce it off them.
+    Returns true if the ball hit something.
+*/
+bool collideBallWithBlocks(rectangle *ball)
+{
+    bool flipX = false;
+    bool flipY = false;
+
+    int prevX = ball->x - ball->velocityX;
+    int prevY = ball->y - ball->velocityY;
+
+    /* Broadphase: cells the ball overlaps */
+    int cx1 = ball->x / CELL_SIZE;
+    int cy1 = ball->y / CELL_SIZE;
+    int cx2 = (ball->x + ball->width - 1) / CELL_SIZE;
+    int cy2 = (ball->y + ball->height - 1) / CELL_SIZE;
+
+    if (cx1 < 0)
+        cx1 = 0;
+    if (cy1 < 0)
+        cy1 = 0;
+    if (cx2 >= GRID_COLS)
+        cx2 = GRID_COLS - 1;
+    if (cy2 >= GRID_ROWS)
+        cy2 = GRID_ROWS - 1;
+
+    blockGrid.blockTests = 0;
+
+    for (int cy = cy1; cy <= cy2; cy++)
+    {
+        for (int cx = cx1; cx <= cx2; cx++)
+        {
+            gridCell *cell = &blockGrid.cells[cy][cx];
+
+            /* Narrow phase: bounding boxes of the cell's blocks */
+            for (int k = 0; k < cell->count; k++)
+            {
+                int index = cell->blocks[k];
+                if (!isBlockAlive(index))
+                    continue;
+
+                int x, y;
+                blockPosition(index, &x, &y);
+                blockGrid.blockTests++;
+
+                if (!(ball->x + ball->width > x && ball->x < x + BLOCK_WIDTH &&
+                      ball->y + ball->height > y && ball->y < y + BLOCK_HEIGHT))
+                    continue;
+
+                /* If the ball already overlapped horizontally it came from above or below */
+                if (prevX + ball->width > x && prevX < x + BLOCK_WIDTH)
+                    flipY = true;
+                else if (prevY + ball->height > y && prevY < y + BLOCK_HEIGHT)
+                    flipX = true;
+                else
+                    flipX = flipY = true;
+
+                destroyBlock(index);
+            }
+        }
+    }
+
+    if (blockGrid.blockTests > blockGrid.maxBlockTests)
+        blockGrid.maxBlockTests = blockGrid.blockTests;
+
+    if (flipX)
+        ball->velocityX *= -1;
+    if (flipY)
+        ball->velocityY *= -1;
+
+    return flipX || flipY;
+}
+
+/* Mark blocks whose alive bit differs from before for a repaint, e.g. after a rewind */
+void markChangedBlocks(u32 aliveBefore[BLOCK_WORDS])
+{
+    for (int word = 0; word < BLOCK_WORDS; word++)
+    {
+        blockGrid.redrawPending[word] |= aliveBefore[word] ^ game.blockAlive[word];
+    }
+}
+
+/* Forget pending repaints, when the whole block set is about to be drawn */
+void clearPendingBlocks()
+{
+    for (int word = 0; word < BLOCK_WORDS; word++)
+    {
+        blockGrid.redrawPending[word] = 0;
+    }
+}
+
+/* Queue repaints of marked blocks, after anything that could clear over them */
+void queuePendingBlocks()
+{
+    for (int word = 0; word < BLOCK_WORDS; word++)
+    {
+        u32 changed = blockGrid.redrawPending[word];
+        if (changed == 0)
+            continue;
+
+        blockGrid.redrawPending[word] = 0;
+
+        for (int bit = 0; bit < 32; bit++)
+        {
+            if (!(changed & (1u << bit)))
+                continue;
+
+            int index = word * 32 + bit;
+            int x, y;
+            blockPosition(index, &x, &y);
+
+            if (isBlockAlive(index))
+                queueBlock(index);
+            else
+                queueClearRegion(x, y, x + BLOCK_WIDTH, y + BLOCK_HEIGHT);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/*  Paddle Bounce Response Tables
+
+    The ball's new velocity depends on where it hits the paddle. Instead of
+    working that out with comparisons on every bounce, the response for each
+    paddle size and ball speed tier is generated by the preprocessor into a
+    const (ROM) table, and bounceOffPaddle does a single lookup.
+
+    Thresholds scale with paddle height. For the normal 24 pixel paddle they
+    are 3 and 6 pixels for Y speed, and 4 pixels for the centre speed boost.
+
+    There is a row for every multiple of PADDLE_HEIGHT_STEP up to
+    PADDLE_HEIGHT_MAX. Other heights use the nearest row.
+*/
+
+#define PADDLE_HEIGHT_STEP 8
+#define PADDLE_HEIGHT_MAX 40
+#define PADDLE_SIZES (PADDLE_HEIGHT_MAX / PADDLE_HEIGHT_STEP)
+#define PADDLE_SIZE_INDEX(height) ((height) / PADDLE_HEIGHT_STEP - 1)
+
+/* Paddle heights, for size power-ups */
+#define PADDLE_HEIGHT_SMALL 16
+#define PADDLE_HEIGHT_NORMAL 24
+#define PADDLE_HEIGHT_LARGE 32
+
+/* Fails to compile for a height without its own row in the table */
+#define BOUNCE_CHECK_HEIGHT(height)                                                   \
+    _Static_assert((height) % PADDLE_HEIGHT_STEP == 0 && (height) > 0 &&              \
+                       (height) <= PADDLE_HEIGHT_MAX && (height) / 2 < BOUNCE_REACH, \
+                   "paddle height " #height " has no bounce table row")
+
+/* Ball speed tiers, for difficulty settings */
+enum ballSpeed
+{
+    BALL_SPEED_NORMAL,
+    BALL_SPEED_FAST,
+    BALL_SPEED_FASTER,
+    BALL_SPEED_TIERS
+};
+
+/* Table covers y_diff (ball centre - paddle centre) from -32 to 31 */
+#define BOUNCE_REACH 32
+#define BOUNCE_SPAN (2 * BOUNCE_REACH)
+
+typedef struct
+{
+    s8 velocityY;
+    u8 speedX;
+} bounceResponse;
+
+/* Y Velocity from distance to centre of paddle: -3 to 3 */
+#define BOUNCE_VY(d, h)                    \
+    (((d) > 0) - ((d) < 0) +               \
+     ((d) > (h) / 8) - ((d) < -(h) / 8) + \
+     ((d) > (h) / 4) - ((d) < -(h) / 4))
+
+/* X speed is 3 for the tier, plus 1 if it hits near the centre */
+#define BOUNCE_SPEED(d, h, tier) \
+    (3 + (tier) + (1 - (((d) > (h) / 6) || ((d) < -(h) / 6))))
+
+#define BOUNCE_ENTRY(i, h, tier) \
+    {BOUNCE_VY((i) - BOUNCE_REACH, h), BOUNCE_SPEED((i) - BOUNCE_REACH, h, tier)}
+
+#define BOUNCE_ENTRIES_8(i, h, tier)                                                   \
+    BOUNCE_ENTRY((i), h, tier), BOUNCE_ENTRY((i) + 1, h, tier),                        \
+        BOUNCE_ENTRY((i) + 2, h, tier), BOUNCE_ENTRY((i) + 3, h, tier),                \
+        BOUNCE_ENTRY((i) + 4, h, tier), BOUNCE_ENTRY((i) + 5, h, tier),                \
+        BOUNCE_ENTRY((i) + 6, h, tier), BOUNCE_ENTRY((i) + 7, h, tier)
+
+#define BOUNCE_ROW(h, tier)                                                  \
+    {                                                                        \
+        BOUNCE_ENTRIES_8(0, h, tier), BOUNCE_ENTRIES_8(8, h, tier),          \
+            BOUNCE_ENTRIES_8(16, h, tier), BOUNCE_ENTRIES_8(24, h, tier),    \
+            BOUNCE_ENTRIES_8(32, h, tier), BOUNCE_ENTRIES_8(40, h, tier),    \
+            BOUNCE_ENTRIES_8(48, h, tier), BOUNCE_ENTRIES_8(56, h, tier)     \
+    }
+
+#define BOUNCE_TIERS(h)                                                                  \
+    {                                                                                    \
+        BOUNCE_ROW(h, BALL_SPEED_NORMAL), BOUNCE_ROW(h, BALL_SPEED_FAST),                \
+            BOUNCE_ROW(h, BALL_SPEED_FASTER)                                             \
+    }
+
+/* One BOUNCE_TIERS per PADDLE_HEIGHT_STEP, add a row when raising PADDLE_HEIGHT_MAX */
+const bounceResponse bounceTable[PADDLE_SIZES][BALL_SPEED_TIERS][BOUNCE_SPAN] = {
+    BOUNCE_TIERS(8),
+    BOUNCE_TIERS(16),
+    BOUNCE_TIERS(24),
+    BOUNCE_TIERS(32),
+    BOUNCE_TIERS(40),
+};
+
+_Static_assert(PADDLE_SIZE_INDEX(PADDLE_HEIGHT_MAX) == 4, "bounceTable rows don't match PADDLE_HEIGHT_MAX");
+
+BOUNCE_CHECK_HEIGHT(PADDLE_HEIGHT_SMALL);
+BOUNCE_CHECK_HEIGHT(PADDLE_HEIGHT_NORMAL);
+BOUNCE_CHECK_HEIGHT(PADDLE_HEIGHT_LARGE);
+
+/* Look up the bounce for a y_diff, with the height and y_diff clamped to the table */
+const bounceResponse *bounceResponseFor(int paddleHeight, int speedTier, int y_diff)
+{
+    /* Nearest row */
+    int size = PADDLE_SIZE_INDEX(paddleHeight + PADDLE_HEIGHT_STEP / 2);
+    if (size < 0)
+        size = 0;
+    else if (size >= PADDLE_SIZES)
+        size = PADDLE_SIZES - 1;
+
+    if (speedTier < 0)
+        speedTier = 0;
+    else if (speedTier >= BALL_SPEED_TIERS)
+        speedTier = BALL_SPEED_TIERS - 1;
+
+    if (y_diff < -BOUNCE_REACH)
+        y_diff = -BOUNCE_REACH;
+    else if (y_diff >= BOUNCE_REACH)
+        y_diff = BOUNCE_REACH - 1;
+
+    return &bounceTable[size][speedTier][y_diff + BOUNCE_REACH];
+}
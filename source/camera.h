@@ -0,0 +1,126 @@
+/*  BG2 Affine Camera
+
+    In the bitmap modes BG2 is an affine layer, so the whole framebuffer
+    can be shaken or zoomed just by changing the BG2 matrix and reference
+    point. Zoom matrices and shake offsets are precomputed into const
+    tables, and cameraVBlank() uploads them from the VBlank interrupt.
+*/
+
+#define ZOOM_LEVELS 16
+#define SHAKE_FRAMES 16
+
+/* Zoom level i scales by (256 + 4i) / 256, up to about 1.23x */
+#define ZOOM_SCALE(i) (256 + (i) * 4)
+#define ZOOM_PA(i) (65536 / ZOOM_SCALE(i))
+
+/* Reference point (20.8 fixed) that keeps the centre of the screen in place */
+#define ZOOM_REF(i, centre) (((centre) << 8) - ZOOM_PA(i) * (centre))
+
+#define ZOOM_ENTRY(i) \
+    {ZOOM_PA(i), ZOOM_REF(i, SCREEN_WIDTH / 2), ZOOM_REF(i, SCREEN_HEIGHT / 2)}
+
+typedef struct
+{
+    s16 scale;
+    s32 refX;
+    s32 refY;
+} zoomMatrix;
+
+const zoomMatrix zoomTable[ZOOM_LEVELS] = {
+    ZOOM_ENTRY(0), ZOOM_ENTRY(1), ZOOM_ENTRY(2), ZOOM_ENTRY(3),
+    ZOOM_ENTRY(4), ZOOM_ENTRY(5), ZOOM_ENTRY(6), ZOOM_ENTRY(7),
+    ZOOM_ENTRY(8), ZOOM_ENTRY(9), ZOOM_ENTRY(10), ZOOM_ENTRY(11),
+    ZOOM_ENTRY(12), ZOOM_ENTRY(13), ZOOM_ENTRY(14), ZOOM_ENTRY(15),
+};
+
+/* Decaying shake, in pixels */
+const s8 shakeOffsets[SHAKE_FRAMES][2] = {
+    {3, -2}, {-3, 2}, {2, 3}, {-2, -3},
+    {3, 1}, {-2, -1}, {1, 2}, {-2, -2},
+    {2, 1}, {-1, -1}, {1, 1}, {-1, 0},
+    {1, 0}, {0, -1}, {0, 1}, {0, 0},
+};
+
+typedef struct
+{
+    int zoomLevel;
+    int zoomTarget;
+    int zoomHoldFrames;
+    int shakeFrame; // -1 when not shaking
+    volatile bool isDirty;
+} bgCamera;
+
+bgCamera camera = {0, 0, 0, -1, true};
+
+/* Shake the screen, e.g. on a goal */
+void cameraShake()
+{
+    camera.shakeFrame = 0;
+    camera.isDirty = true;
+}
+
+/* Zoom in, hold for a number of frames, then zoom back out */
+void cameraZoomPulse(int holdFrames)
+{
+    camera.zoomHoldFrames = holdFrames;
+    camera.zoomTarget = ZOOM_LEVELS - 1;
+    camera.isDirty = true;
+}
+
+/* Stop shaking and ease the zoom back out */
+void cameraSettle()
+{
+    camera.shakeFrame = -1;
+    camera.zoomHoldFrames = 0;
+    camera.zoomTarget = 0;
+    camera.isDirty = true;
+}
+
+/* Call once per VBlank, steps the effects and uploads the BG2 registers */
+void cameraVBlank()
+{
+    if (!camera.isDirty)
+        return;
+
+    /* Ease zoom one level per frame towards its target */
+    if (camera.zoomLevel < camera.zoomTarget)
+    {
+        camera.zoomLevel++;
+    }
+    else if (camera.zoomLevel > camera.zoomTarget)
+    {
+        camera.zoomLevel--;
+    }
+    else if (camera.zoomHoldFrames > 0)
+    {
+        camera.zoomHoldFrames--;
+        if (camera.zoomHoldFrames == 0)
+            camera.zoomTarget = 0;
+    }
+
+    const zoomMatrix *zoom = &zoomTable[camera.zoomLevel];
+    int refX = zoom->refX;
+    int refY = zoom->refY;
+
+    if (camera.shakeFrame >= 0)
+    {
+        refX += shakeOffsets[camera.shakeFrame][0] << 8;
+        refY += shakeOffsets[camera.shakeFrame][1] << 8;
+
+        camera.shakeFrame++;
+        if (camera.shakeFrame >= SHAKE_FRAMES)
+            camera.shakeFrame = -1;
+    }
+
+    REG_BG2PA = zoom->scale;
+    REG_BG2PB = 0;
+    REG_BG2PC = 0;
+    REG_BG2PD = zoom->scale;
+    REG_BG2X = refX;
+    REG_BG2Y = refY;
+
+    /* Keep uploading until every effect has settled */
+    camera.isDirty = camera.shakeFrame >= 0 ||
+                     camera.zoomLevel != camera.zoomTarget ||
+                     camera.zoomHoldFrames > 0;
+}
@@ -0,0 +1,280 @@
+/*  Deferred Draw Command Queue
+
+    Game logic records fill, clear and glyph commands while the screen is
+    being drawn, and flushDrawQueue() replays them at the start of VBlank so
+    framebuffer writes never race the scanout. Each flush is limited to a
+    cycle budget; commands that don't fit stay queued for the next VBlank.
+
+    The flush is timed with the cycle timer, and the cost of the next
+    command is estimated from per command and per pixel costs measured by
+    calibrateDrawQueue() at boot.
+*/
+
+#define DRAW_QUEUE_SIZE 96
+
+/* VBlank is 68 scanlines of 1232 cycles. Leave some room for input and
+   interrupt overhead so the flush always finishes before line 0. */
+const int VBLANK_CYCLE_BUDGET = 68 * 1232 - 8192;
+
+enum drawCommandType
+{
+    DRAW_FILL,
+    DRAW_CLEAR,
+    DRAW_GLYPH
+};
+
+/* Commands that share a pixel loop share a cost */
+enum drawCostKind
+{
+    DRAW_COST_FILL,
+    DRAW_COST_GLYPH_1X,
+    DRAW_COST_GLYPH_2X,
+    DRAW_COST_KINDS
+};
+
+typedef struct
+{
+    int overhead;    // Cycles per command
+    int perPixel256; // Cycles per pixel, 8.8 fixed point
+} drawCost;
+
+typedef struct
+{
+    u8 type;
+    u8 scale;
+    u16 color;
+    s16 x;
+    s16 y;
+    s16 width;
+    s16 height;
+    bool *glyph;
+} drawCommand;
+
+typedef struct
+{
+    drawCommand commands[DRAW_QUEUE_SIZE];
+    int head;
+    int count;
+
+    /* Counters */
+    int overflowCount;  // Commands dropped because the queue was full
+    int carryOverCount; // Flushes that ran out of budget and left work queued
+    int maxPending;     // Deepest the queue has been at flush time
+    int lastFlushCycles; // Measured
+    int maxFlushCycles;
+
+    /* Conservative guesses, replaced by calibrateDrawQueue() */
+    drawCost costs[DRAW_COST_KINDS];
+} drawQueue;
+
+drawQueue drawCommands = {
+    .costs = {{64, 8 << 8}, {1024, 0}, {4096, 0}},
+};
+
+/* Drop everything queued, e.g. when the whole screen is about to be replaced */
+void resetDrawQueue()
+{
+    drawCommands.head = 0;
+    drawCommands.count = 0;
+}
+
+/* Add a command to the back of the queue */
+void queueCommand(drawCommand *command)
+{
+    if (drawCommands.count >= DRAW_QUEUE_SIZE)
+    {
+        drawCommands.overflowCount++;
+        return;
+    }
+
+    int tail = (drawCommands.head + drawCommands.count) % DRAW_QUEUE_SIZE;
+    drawCommands.commands[tail] = *command;
+    drawCommands.count++;
+}
+
+void queueFill(int x, int y, int width, int height, int color)
+{
+    drawCommand command = {DRAW_FILL, 1, color, x, y, width, height, 0};
+    queueCommand(&command);
+}
+
+void queueRectangle(rectangle *rectangle, int color)
+{
+    queueFill(rectangle->x, rectangle->y, rectangle->width, rectangle->height, color);
+}
+
+/* Queued versions of clearRegion / clearPreviousPosition */
+void queueClearRegion(int x1, int y1, int x2, int y2)
+{
+    drawCommand command = {DRAW_CLEAR, 1, CLR_BLACK, x1, y1, x2 - x1, y2 - y1, 0};
+    queueCommand(&command);
+}
+
+void queueClearPrevious(rectangle *rectangle)
+{
+    queueClearRegion(rectangle->prevX, rectangle->prevY,
+                     rectangle->prevX + rectangle->width, rectangle->prevY + rectangle->height);
+}
+
+/* 8x8 glyph from characters.h, drawn at 1x (normal text) or 2x (scores) */
+void queueGlyph(bool glyph[64], int x, int y, int scale)
+{
+    drawCommand command = {DRAW_GLYPH, scale, CLR_WHITE, x, y,
+                           CHAR_PIX_SIZE * scale, CHAR_PIX_SIZE * scale, glyph};
+    queueCommand(&command);
+}
+
+/* Queued version of displayText, same character rules */
+void queueText(char textBuffer[], int x, int y)
+{
+    for (int i = 0; i < NUM_CHARS_LINE; i++)
+    {
+        queueGlyph(glyphForChar(textBuffer[i]), x + i * CHAR_PIX_SIZE, y, 1);
+    }
+}
+
+/* Queued version of drawCenterLine, one fill per dash */
+void queueCenterLine()
+{
+    for (int j = 0; j < SCREEN_HEIGHT; j += 8)
+    {
+        queueFill(SCREEN_WIDTH / 2, j + 2, 2, 4, CLR_WHITE);
+    }
+}
+
+void queuePlayerScore(bool scoreArray[64])
+{
+    queueGlyph(scoreArray, SCREEN_WIDTH / 4 - 8, SCORE_Y, 2);
+}
+
+void queueCpuScore(bool scoreArray[64])
+{
+    queueGlyph(scoreArray, 3 * SCREEN_WIDTH / 4 - 8, SCORE_Y, 2);
+}
+
+int drawCostKind(drawCommand *command)
+{
+    if (command->type != DRAW_GLYPH)
+        return DRAW_COST_FILL;
+
+    return command->scale == 2 ? DRAW_COST_GLYPH_2X : DRAW_COST_GLYPH_1X;
+}
+
+/* Estimated cost of running a command */
+int drawCommandCycles(drawCommand *command)
+{
+    drawCost *cost = &drawCommands.costs[drawCostKind(command)];
+    return cost->overhead + ((command->width * command->height * cost->perPixel256) >> 8);
+}
+
+void runDrawCommand(drawCommand *command)
+{
+    switch (command->type)
+    {
+    case DRAW_FILL:
+    case DRAW_CLEAR:
+        for (int j = command->y; j < command->y + command->height; j++)
+        {
+            for (int i = command->x; i < command->x + command->width; i++)
+            {
+                m3_mem[j][i] = command->color;
+            }
+        }
+        break;
+
+    case DRAW_GLYPH:
+    {
+        /* Scale is 1 or 2, shift instead of dividing (no hardware divide) */
+        int shift = command->scale - 1;
+
+        for (int i = 0; i < command->height; i++)
+        {
+            for (int j = 0; j < command->width; j++)
+            {
+                int color = CLR_BLACK;
+                if (command->glyph[(i >> shift) * 8 + (j >> shift)])
+                    color = command->color;
+
+                m3_mem[command->y + i][command->x + j] = color;
+            }
+        }
+        break;
+    }
+    }
+}
+
+/* Time a command, best of a few runs so an interrupt doesn't skew it */
+u32 measureDrawCommand(drawCommand *command)
+{
+    u32 best = 0xFFFFFFFF;
+
+    for (int run = 0; run < 4; run++)
+    {
+        startCycleTimer();
+        runDrawCommand(command);
+        u32 cycles = stopCycleTimer();
+
+        if (cycles < best)
+            best = cycles;
+    }
+
+    return best;
+}
+
+/*  Measure the real cost of each kind of command. Draws black into the
+    top left corner, so call it before anything is on screen.
+*/
+void calibrateDrawQueue()
+{
+    /* Fills: a tiny and a large one give the per command and per pixel costs */
+    drawCommand small = {DRAW_CLEAR, 1, CLR_BLACK, 0, 0, 1, 1, 0};
+    drawCommand large = {DRAW_CLEAR, 1, CLR_BLACK, 0, 0, 32, 32, 0};
+
+    u32 smallCycles = measureDrawCommand(&small);
+    u32 largeCycles = measureDrawCommand(&large);
+
+    drawCost *fill = &drawCommands.costs[DRAW_COST_FILL];
+    fill->perPixel256 = ((largeCycles - smallCycles) << 8) / (32 * 32 - 1);
+    fill->overhead = smallCycles - (fill->perPixel256 >> 8);
+
+    /* Glyphs are always the same size, so their whole cost is per command */
+    drawCommand glyph = {DRAW_GLYPH, 1, CLR_BLACK, 0, 0, CHAR_PIX_SIZE, CHAR_PIX_SIZE, score[8]};
+    drawCommands.costs[DRAW_COST_GLYPH_1X].overhead = measureDrawCommand(&glyph);
+
+    glyph.scale = 2;
+    glyph.width = glyph.height = CHAR_PIX_SIZE * 2;
+    drawCommands.costs[DRAW_COST_GLYPH_2X].overhead = measureDrawCommand(&glyph);
+}
+
+/*  Run queued commands in order until the budget is spent. The first
+    command always runs, so one oversized command can't stall the queue.
+*/
+void flushDrawQueue()
+{
+    if (drawCommands.count > drawCommands.maxPending)
+        drawCommands.maxPending = drawCommands.count;
+
+    startCycleTimer();
+
+    bool hasRun = false;
+    while (drawCommands.count > 0)
+    {
+        drawCommand *command = &drawCommands.commands[drawCommands.head];
+
+        if (hasRun && readCycleTimer() + drawCommandCycles(command) > (u32)VBLANK_CYCLE_BUDGET)
+        {
+            drawCommands.carryOverCount++;
+            break;
+        }
+
+        runDrawCommand(command);
+        hasRun = true;
+
+        drawCommands.head = (drawCommands.head + 1) % DRAW_QUEUE_SIZE;
+        drawCommands.count--;
+    }
+
+    drawCommands.lastFlushCycles = stopCycleTimer();
+    if (drawCommands.lastFlushCycles > drawCommands.maxFlushCycles)
+        drawCommands.maxFlushCycles = drawCommands.lastFlushCycles;
+}
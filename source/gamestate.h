@@ -0,0 +1,125 @@
+/*  Game State Arena
+
+    Everything that changes during a match lives in one contiguous block in
+    IWRAM, so resetting, snapshotting and restoring are each a single
+    CpuFastSet of a fixed size. Snapshots carry a layout header (magic,
+    version and size) that is checked before they are restored, so bump
+    GAME_STATE_VERSION whenever the layout changes.
+
+    The rewind buffer keeps a snapshot from before each of the last few
+    seconds of logic steps.
+*/
+
+#define GAME_STATE_MAGIC 0x474E4F50 // "PONG"
+#define GAME_STATE_VERSION 2
+#define REWIND_FRAMES 180           // 3 Seconds
+
+/* Obstacle mode block layout, the blocks themselves are in blocks.h */
+#define BLOCK_COLS 12
+#define BLOCK_ROWS 28
+#define BLOCK_COUNT (BLOCK_COLS * BLOCK_ROWS)
+#define BLOCK_WORDS ((BLOCK_COUNT + 31) / 32)
+
+enum gameMode
+{
+    GAME_CLASSIC,
+    GAME_OBSTACLE
+};
+
+/* Aligned to 32 bytes so the size is a whole number of CpuFastSet blocks */
+typedef struct
+{
+    /* Layout header */
+    u32 magic;
+    u16 version;
+    u16 size;
+
+    /* Settings, kept across resets */
+    int gameMode;
+    int ballSpeedTier;
+
+    /* Match */
+    rectangle player;
+    rectangle cpuPlayer;
+    rectangle ball;
+    int playerScore;
+    int cpuScore;
+    int pauseCounter;
+    int pauseLength;
+    bool isGamePaused;
+    bool isMatchOver;
+
+    /* Obstacle mode */
+    u32 blockAlive[BLOCK_WORDS];
+    int blocksRemaining;
+} __attribute__((aligned(32))) gameArena;
+
+#define GAME_STATE_WORDS (sizeof(gameArena) / 4)
+
+IWRAM_DATA gameArena game;
+
+/* State of a new match, filled in once at boot */
+gameArena gameDefaults;
+
+typedef struct
+{
+    gameArena frames[REWIND_FRAMES];
+    int head;
+    int count;
+} rewindBuffer;
+
+EWRAM_BSS rewindBuffer rewindHistory;
+
+void gameSnapshot(gameArena *snapshot)
+{
+    CpuFastSet(&game, snapshot, GAME_STATE_WORDS);
+}
+
+/* Restore a snapshot, refusing one saved with a different layout */
+bool gameRestore(gameArena *snapshot)
+{
+    if (snapshot->magic != GAME_STATE_MAGIC ||
+        snapshot->version != GAME_STATE_VERSION ||
+        snapshot->size != sizeof(gameArena))
+        return false;
+
+    CpuFastSet(snapshot, &game, GAME_STATE_WORDS);
+    return true;
+}
+
+/* Start a new match, keeping the current settings */
+void gameReset()
+{
+    int mode = game.gameMode;
+    int speedTier = game.ballSpeedTier;
+
+    CpuFastSet(&gameDefaults, &game, GAME_STATE_WORDS);
+
+    game.gameMode = mode;
+    game.ballSpeedTier = speedTier;
+
+    rewindHistory.head = 0;
+    rewindHistory.count = 0;
+}
+
+/* Save the current state before running a logic step */
+void rewindPush()
+{
+    gameSnapshot(&rewindHistory.frames[rewindHistory.head]);
+
+    rewindHistory.head = (rewindHistory.head + 1) % REWIND_FRAMES;
+    if (rewindHistory.count < REWIND_FRAMES)
+        rewindHistory.count++;
+}
+
+/* Go back one logic step, returns false when out of history */
+bool rewindPop()
+{
+    if (rewindHistory.count == 0)
+        return false;
+
+    rewindHistory.head = (rewindHistory.head + REWIND_FRAMES - 1) % REWIND_FRAMES;
+    rewindHistory.count--;
+
+    return gameRestore(&rewindHistory.frames[rewindHistory.head]);
+}
@@ -14,7 +14,7 @@
 #define CLR_CYAN 0x7FE0
 #define CLR_WHITE 0x7FFF
 
-const int CHAR_PIX_SIZE = 8;
+#define CHAR_PIX_SIZE 8
 const int LINE_HEIGHT = 12;
 const int NUM_CHARS_LINE = 10;
 
@@ -26,7 +26,7 @@ const int MENU_ITEM_2 = MENU_ITEM_1 + LINE_HEIGHT;
 const int END_TEXT_X = ((SCREEN_WIDTH / 2) - (CHAR_PIX_SIZE * NUM_CHARS_LINE / 2));
 const int END_TEXT_Y = (SCREEN_HEIGHT / 2) - (CHAR_PIX_SIZE / 2);
 
-const int SCORE_Y = 10;
+#define SCORE_Y 10
 const int PLAYER_SYM_Y = (SCREEN_HEIGHT - LINE_HEIGHT - SCORE_Y);
 
 typedef u16 M3LINE[SCREEN_WIDTH];
@@ -79,6 +79,13 @@ void clearRegion(int x1, int y1, int x2, int y2)
     }
 }
 
+/* Clear the Whole Screen, with the BIOS fast fill */
+void clearScreen()
+{
+    u32 black = CLR_BLACK;
+    CpuFastSet(&black, (void *)MEM_VRAM, FILL | (SCREEN_WIDTH * SCREEN_HEIGHT / 2));
+}
+
 /* Draw Net / Center Line */
 void drawCenterLine()
 {
@@ -140,38 +147,45 @@ void printChar(bool characterArray[64], int x, int y)
     }
 }
 
-/*  Display text string (made of characters.h chars). Only capital
-    letters, numbers, and some punctuation, not full ascii.
+/* Look up the characters.h glyph for a character. Only capital
+   letters, numbers, and some punctuation, not full ascii.
+*/
+bool *glyphForChar(char character)
+{
+    // Space
+    if (character == 0x20)
+    {
+        return selector[0];
+        // Exclamation point
+    }
+    else if (character == 0x21)
+    {
+        return punctuation[1];
+        // Period
+    }
+    else if (character == 0x2E)
+    {
+        return punctuation[0];
+        // Numbers
+    }
+    else if (character >= 0x30 && character <= 0x39)
+    {
+        return score[character - 0x30];
+        // Letters
+    }
+    else
+    {
+        return alphabet[character - 0x41];
+    }
+}
+
+/*  Display text string (made of characters.h chars).
     Limited to NUM_CHARS_LINE characters per line.
 */
 void displayText(char textBuffer[], int x, int y)
 {
     for (int i = 0; i < NUM_CHARS_LINE; i++)
     {
-        // Space
-        if (textBuffer[i] == 0x20)
-        {
-            printChar(selector[0], x + i * 8, y);
-            // Exclamation point
-        }
-        else if (textBuffer[i] == 0x21)
-        {
-            printChar(punctuation[1], x + i * 8, y);
-            // Period
-        }
-        else if (textBuffer[i] == 0x2E)
-        {
-            printChar(punctuation[0], x + i * 8, y);
-            // Numbers
-        }
-        else if (textBuffer[i] >= 0x30 && textBuffer[i] <= 0x39)
-        {
-            printChar(score[textBuffer[i] - 0x30], x + i * 8, y);
-            // Letters
-        }
-        else
-        {
-            printChar(alphabet[textBuffer[i] - 0x41], x + i * 8, y);
-        }
+        printChar(glyphForChar(textBuffer[i]), x + i * 8, y);
     }
-}
+}
\ No newline at end of file
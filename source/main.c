@@ -2,9 +2,24 @@
 #include <gba_interrupt.h>
 #include <gba_systemcalls.h>
 #include <gba_input.h>
+#include <gba_dma.h>
+#include <gba_timers.h>
 #include "graphics.h"
+#include "timing.h"
+#include "drawqueue.h"
+#include "raster.h"
+#include "camera.h"
+#include "trace.h"
+#include "scheduler.h"
+#include "bounce.h"
+#include "gamestate.h"
+#include "blocks.h"
+#include "assets.h"
+#include "menu.h"
+
+#define PADDLE_HEIGHT PADDLE_HEIGHT_NORMAL
+BOUNCE_CHECK_HEIGHT(PADDLE_HEIGHT);
 
-const int PADDLE_HEIGHT = 24;
 const int PADDLE_WIDTH = 8;
 const int BALL_SIZE = 8;
 
@@ -15,19 +30,19 @@ const int HALF_PAUSE = (ROUND_PAUSE / 2);
 const int BALL_START_X = (SCREEN_WIDTH / 2) - (BALL_SIZE / 2) + 1; 
 const int PLAYER_START_Y = ((SCREEN_HEIGHT / 2) - (PADDLE_HEIGHT / 2));
 
-int pauseLength = NEW_GAME_PAUSE;
-
-bool isGamePaused = true;
-
-/* Show menu cursor on current selection */
-void setMenuCursor(int selection)
+enum gameState
 {
-    /* Clear Cursor */
-    clearRegion(MENU_TEXT_X - CHAR_PIX_SIZE, MENU_ITEM_1, MENU_TEXT_X, MENU_ITEM_2 + CHAR_PIX_SIZE);
+    STATE_MENU,
+    STATE_MATCH
+};
 
-    /* Show Cursor on selection */
-    printChar(selector[1], MENU_TEXT_X - CHAR_PIX_SIZE, MENU_ITEM_1 + (selection)*LINE_HEIGHT);
-}
+/* Menu Screens */
+menuScreen mainMenu;
+menuScreen optionsMenu;
+menuScreen gameOverMenu;
+
+menuWidget *modeLabel;
+menuWidget *speedLabel;
 
 /* Bounding Box Collision Detection */
 bool hasCollision(
@@ -38,82 +53,98 @@ bool hasCollision(
             y1 + height1 > y2 && y1 < y2 + height2);
 }
 
-/* Paddle Bounce Logic - Tweak as needed depending on paddle size */
+/* Paddle Bounce Logic - response comes from the tables in bounce.h */
 void bounceOffPaddle(rectangle *playerPaddle, rectangle *ball)
 {
-    int y_diff = (ball->y + (BALL_SIZE / 2)) - (playerPaddle->y + (PADDLE_HEIGHT / 2));
+    int y_diff = (ball->y + (BALL_SIZE / 2)) - (playerPaddle->y + (playerPaddle->height / 2));
 
-    /* Set Y Velocity according to distance from center of paddle */
-    ball->velocityY = ((y_diff > 0) - (y_diff < 0)) +
-                      ((y_diff > 3) - (y_diff < -3)) +
-                      ((y_diff > 6) - (y_diff < -6));
+    const bounceResponse *response = bounceResponseFor(playerPaddle->height, game.ballSpeedTier, y_diff);
 
-    /* Set X Velocity to +/- 3, and add 1 to X speed if hits near center */
-    ball->velocityX = ((ball->velocityX < 0) - (ball->velocityX > 0)) * (3 + (1 - ((y_diff > 4) || (y_diff < -4))));
+    /* Y Velocity according to distance from center of paddle, X Velocity reversed */
+    ball->velocityY = response->velocityY;
+    ball->velocityX = ((ball->velocityX < 0) - (ball->velocityX > 0)) * response->speedX;
 }
 
 /* Scoring Points */
-void playerScores(bool isHuman, rectangle *ball, int *humanScore, int *cpuScore)
+void playerScores(bool isHuman)
 {
     /* Increment Score */
-    int *playerScore;
+    int *points;
+
+    if (isHuman)
+        points = &game.playerScore;
+    else
+        points = &game.cpuScore;
+
+    *points = *points + 1;
+    game.isGamePaused = true;
+    TRACE(TRACE_SCORE, isHuman, *points);
 
+    /* Tint the score band in the scorer's colour until the next rally */
     if (isHuman)
-        playerScore = humanScore;
+        rasterSetScoreTint(COLOR_RGB(0, 10, 0));
     else
-        playerScore = cpuScore;
+        rasterSetScoreTint(COLOR_RGB(10, 0, 0));
 
-    *playerScore = *playerScore + 1;
-    isGamePaused = true;
+    cameraShake();
 
-    /* If Winning Score, Show Winner and Reset */
-    if (*playerScore >= 10)
+    /* If Winning Score, Show Winner and end the match after the pause */
+    if (*points >= 10)
     {
-        clearRegion(SCREEN_WIDTH / 2, MENU_TEXT_Y, SCREEN_WIDTH / 2 + 2, MENU_TEXT_Y + 30);
+        game.isMatchOver = true;
+        game.pauseLength = NEW_GAME_PAUSE;
+        queueClearRegion(SCREEN_WIDTH / 2, MENU_TEXT_Y, SCREEN_WIDTH / 2 + 2, MENU_TEXT_Y + 30);
+        rasterFlash(HALF_PAUSE);
 
         if (isHuman)
         {
-            displayText(" YOU WIN! ", END_TEXT_X, END_TEXT_Y);
+            queueText(" YOU WIN! ", END_TEXT_X, END_TEXT_Y);
         }
         else
         {
-            displayText(" CPU WINS ", END_TEXT_X, END_TEXT_Y);
+            queueText(" CPU WINS ", END_TEXT_X, END_TEXT_Y);
         }
     }
     else
     {
-        ball->velocityX *= -1;
-        pauseLength = ROUND_PAUSE;
+        game.ball.velocityX *= -1;
+        game.pauseLength = ROUND_PAUSE;
+
+        /* Zoom in while paused on match point */
+        if (*points == 9)
+            cameraZoomPulse(HALF_PAUSE);
     }
 }
 
-/* Game Logic */
-void matchMode(rectangle *player, rectangle *cpuPlayer, rectangle *ball, int *playerScore, int *cpuScore, int *pauseCounter)
+/* Game Logic, runs one step on the match state in the game arena */
+void matchMode()
 {
     /* If players are rallying */
-    if (!isGamePaused)
+    if (!game.isGamePaused)
     {
         /* If ball has hit opponents wall, player scores */
-        if (ball->x <= 3 && ball->velocityX < 0)
+        if (game.ball.x <= 3 && game.ball.velocityX < 0)
         {
-            ball->x = player->x;
-            playerScores(false, ball, playerScore, cpuScore);
+            game.ball.x = game.player.x;
+            playerScores(false);
         }
 
-        else if (ball->x >= SCREEN_WIDTH - ball->width - 3 && ball->velocityX > 0)
+        else if (game.ball.x >= SCREEN_WIDTH - game.ball.width - 3 && game.ball.velocityX > 0)
         {
-            ball->x = cpuPlayer->x + PADDLE_WIDTH - BALL_SIZE;
-            playerScores(true, ball, playerScore, cpuScore);
+            game.ball.x = game.cpuPlayer.x + PADDLE_WIDTH - BALL_SIZE;
+            playerScores(true);
         }
         /* If ball hits ceiling or floor, bounce off */
-        if (ball->y <= 0 && ball->velocityY < 0)
+        if (game.ball.y <= 0 && game.ball.velocityY < 0)
         {
-            ball->velocityY *= -1;
+            game.ball.velocityY *= -1;
+            TRACE(TRACE_BOUNCE_WALL, 0, game.ball.velocityX);
         }
 
-        else if (ball->y >= SCREEN_HEIGHT - ball->height && ball->velocityY > 0)
+        else if (game.ball.y >= SCREEN_HEIGHT - game.ball.height && game.ball.velocityY > 0)
         {
-            ball->velocityY *= -1;
+            game.ball.velocityY *= -1;
+            TRACE(TRACE_BOUNCE_WALL, 1, game.ball.velocityX);
         }
 
         /* Move human player based on input */
@@ -122,123 +153,257 @@ void matchMode(rectangle *player, rectangle *cpuPlayer, rectangle *ball, int *pl
 
         if ((keys_released & KEY_UP) || (keys_released & KEY_DOWN))
         {
-            player->velocityY = 0;
+            game.player.velocityY = 0;
         }
-        if ((keys_pressed & KEY_UP) && (player->y >= 0))
+        if ((keys_pressed & KEY_UP) && (game.player.y >= 0))
         {
-            player->velocityY = -2;
+            game.player.velocityY = -2;
         }
         if ((keys_pressed & KEY_DOWN) &&
-            (player->y <= SCREEN_HEIGHT - player->height))
+            (game.player.y <= SCREEN_HEIGHT - game.player.height))
         {
-            player->velocityY = 2;
+            game.player.velocityY = 2;
         }
-        if ((player->y <= 0 && player->velocityY < 0) ||
-            ((player->y >= SCREEN_HEIGHT - player->height) &&
-             player->velocityY > 0))
+        if ((game.player.y <= 0 && game.player.velocityY < 0) ||
+            ((game.player.y >= SCREEN_HEIGHT - game.player.height) &&
+             game.player.velocityY > 0))
         {
-            player->velocityY = 0;
+            game.player.velocityY = 0;
         }
 
         /* Computer Player Movement Logic */
-        if (ball->y + (BALL_SIZE - 2) > cpuPlayer->y + (PADDLE_HEIGHT / 2) &&
-            cpuPlayer->y + PADDLE_HEIGHT <= SCREEN_HEIGHT &&
-            ball->x > SCREEN_WIDTH / 4 &&
-            !(ball->velocityY < -2) &&
-            (ball->velocityX > 0 || ball->x > SCREEN_WIDTH / 2))
+        if (game.ball.y + (BALL_SIZE - 2) > game.cpuPlayer.y + (PADDLE_HEIGHT / 2) &&
+            game.cpuPlayer.y + PADDLE_HEIGHT <= SCREEN_HEIGHT &&
+            game.ball.x > SCREEN_WIDTH / 4 &&
+            !(game.ball.velocityY < -2) &&
+            (game.ball.velocityX > 0 || game.ball.x > SCREEN_WIDTH / 2))
         {
-            cpuPlayer->velocityY = 2;
+            game.cpuPlayer.velocityY = 2;
         }
-        else if (ball->y + (BALL_SIZE - 2) < cpuPlayer->y + (PADDLE_HEIGHT / 2) &&
-                 cpuPlayer->y >= 0 &&
-                 ball->x > SCREEN_WIDTH / 4 &&
-                 !(ball->velocityY > 2) &&
-                 (ball->velocityX > 0 || ball->x > SCREEN_WIDTH / 2))
+        else if (game.ball.y + (BALL_SIZE - 2) < game.cpuPlayer.y + (PADDLE_HEIGHT / 2) &&
+                 game.cpuPlayer.y >= 0 &&
+                 game.ball.x > SCREEN_WIDTH / 4 &&
+                 !(game.ball.velocityY > 2) &&
+                 (game.ball.velocityX > 0 || game.ball.x > SCREEN_WIDTH / 2))
         {
-            cpuPlayer->velocityY = -2;
+            game.cpuPlayer.velocityY = -2;
         }
         else
         {
-            cpuPlayer->velocityY = 0;
+            game.cpuPlayer.velocityY = 0;
         }
 
         /* Update Positions */
-        if (!isGamePaused)
+        if (!game.isGamePaused)
+        {
+            game.ball.x += game.ball.velocityX;
+            game.ball.y += game.ball.velocityY;
+            game.player.y += game.player.velocityY;
+            game.cpuPlayer.y += game.cpuPlayer.velocityY;
+        }
+
+        /* Ball breaks through obstacle blocks */
+        if (game.gameMode == GAME_OBSTACLE)
         {
-            ball->x += ball->velocityX;
-            ball->y += ball->velocityY;
-            player->y += player->velocityY;
-            cpuPlayer->y += cpuPlayer->velocityY;
+            collideBallWithBlocks(&game.ball);
         }
 
         /* Wait a moment after score before new rally */
     }
     else
     {
-        *pauseCounter = *pauseCounter + 1;
-        if (*pauseCounter == (int)HALF_PAUSE)
+        game.pauseCounter = game.pauseCounter + 1;
+        if (game.pauseCounter == (int)HALF_PAUSE)
         {
-            ball->x = BALL_START_X;
-            player->y = PLAYER_START_Y;
-            cpuPlayer->y = PLAYER_START_Y;
+            game.ball.x = BALL_START_X;
+            game.player.y = PLAYER_START_Y;
+            game.cpuPlayer.y = PLAYER_START_Y;
         }
-        if (*pauseCounter > pauseLength)
+        if (game.pauseCounter > game.pauseLength)
         {
-            *pauseCounter = 0;
-            isGamePaused = false;
+            game.pauseCounter = 0;
+            game.isGamePaused = false;
+            rasterClearScoreTint();
         }
     }
 
+    /* Check for paddle / ball collisions, if so ball bounces */
+    if (hasCollision(
+            game.player.x, game.player.y,
+            game.player.width, game.player.height,
+            game.ball.x, game.ball.y,
+            game.ball.width, game.ball.height) &&
+        game.ball.velocityX < 0)
+    {
+        bounceOffPaddle(&game.player, &game.ball);
+        TRACE(TRACE_BOUNCE_PADDLE, 1, game.ball.velocityY);
+    }
+    if (hasCollision(
+            game.cpuPlayer.x, game.cpuPlayer.y,
+            game.cpuPlayer.width, game.cpuPlayer.height,
+            game.ball.x, game.ball.y,
+            game.ball.width, game.ball.height) &&
+        game.ball.velocityX > 0)
+    {
+        bounceOffPaddle(&game.cpuPlayer, &game.ball);
+        TRACE(TRACE_BOUNCE_PADDLE, 0, game.ball.velocityY);
+    }
+
+    return;
+}
+
+/* Queue drawing of the current match state for the next VBlank */
+void drawMatch()
+{
     /* Clear Previous Ball, Player Graphics */
-    clearPreviousPosition(ball);
-    clearPreviousPosition(player);
-    clearPreviousPosition(cpuPlayer);
+    queueClearPrevious(&game.ball);
+    queueClearPrevious(&game.player);
+    queueClearPrevious(&game.cpuPlayer);
+
+    /* Blocks a rewind brought back, repainted after the clears above */
+    if (game.gameMode == GAME_OBSTACLE)
+        queuePendingBlocks();
 
-    drawCenterLine();
+    queueCenterLine();
 
-    printPlayerScore(score[*playerScore]);
-    printCpuScore(score[*cpuScore]);
+    queuePlayerScore(score[game.playerScore]);
+    queueCpuScore(score[game.cpuScore]);
 
     /* Draw Ball, Players at current positions */
-    drawRectangle(ball, CLR_LIME);
-    drawRectangle(player, CLR_WHITE);
-    drawRectangle(cpuPlayer, CLR_WHITE);
+    queueRectangle(&game.ball, CLR_LIME);
+    queueRectangle(&game.player, CLR_WHITE);
+    queueRectangle(&game.cpuPlayer, CLR_WHITE);
 
     /* Update previous positions for clearing pixels */
-    ball->prevX = ball->x;
-    ball->prevY = ball->y;
-    player->prevX = player->x;
-    player->prevY = player->y;
-    cpuPlayer->prevX = cpuPlayer->x;
-    cpuPlayer->prevY = cpuPlayer->y;
+    game.ball.prevX = game.ball.x;
+    game.ball.prevY = game.ball.y;
+    game.player.prevX = game.player.x;
+    game.player.prevY = game.player.y;
+    game.cpuPlayer.prevX = game.cpuPlayer.x;
+    game.cpuPlayer.prevY = game.cpuPlayer.y;
+}
 
-    /* Check for paddle / ball collisions, if so ball bounces */
-    if (hasCollision(
-            player->x, player->y,
-            player->width, player->height,
-            ball->x, ball->y,
-            ball->width, ball->height) &&
-        ball->velocityX < 0)
+/* Option labels show the current settings */
+void updateOptionLabels()
+{
+    menuSetLabel(modeLabel, game.gameMode == GAME_CLASSIC ? "CLASSIC" : "BLOCKS");
+
+    char speedText[] = "SPEED 1";
+    speedText[6] = '1' + game.ballSpeedTier;
+    menuSetLabel(speedLabel, speedText);
+}
+
+/* Fill in the state every match starts from */
+void initGameDefaults()
+{
+    gameArena *defaults = &gameDefaults;
+
+    defaults->magic = GAME_STATE_MAGIC;
+    defaults->version = GAME_STATE_VERSION;
+    defaults->size = sizeof(gameArena);
+
+    defaults->gameMode = GAME_CLASSIC;
+    defaults->ballSpeedTier = BALL_SPEED_NORMAL;
+
+    defaults->player.x = 1;
+    defaults->player.y = PLAYER_START_Y;
+    defaults->player.prevX = defaults->player.x;
+    defaults->player.prevY = defaults->player.y;
+    defaults->player.width = PADDLE_WIDTH;
+    defaults->player.height = PADDLE_HEIGHT;
+
+    defaults->cpuPlayer.x = SCREEN_WIDTH - PADDLE_WIDTH - 1;
+    defaults->cpuPlayer.y = PLAYER_START_Y;
+    defaults->cpuPlayer.prevX = defaults->cpuPlayer.x;
+    defaults->cpuPlayer.prevY = defaults->cpuPlayer.y;
+    defaults->cpuPlayer.width = PADDLE_WIDTH;
+    defaults->cpuPlayer.height = PADDLE_HEIGHT;
+
+    defaults->ball.x = BALL_START_X;
+    defaults->ball.y = (SCREEN_HEIGHT / 2) - (BALL_SIZE / 2);
+    defaults->ball.prevX = defaults->ball.x;
+    defaults->ball.prevY = defaults->ball.y;
+    defaults->ball.width = BALL_SIZE;
+    defaults->ball.height = BALL_SIZE;
+    defaults->ball.velocityX = 2;
+    defaults->ball.velocityY = 2;
+
+    defaults->pauseLength = NEW_GAME_PAUSE;
+    defaults->isGamePaused = true;
+
+    for (int i = 0; i < BLOCK_WORDS; i++)
     {
-        bounceOffPaddle(player, ball);
+        defaults->blockAlive[i] = 0xFFFFFFFF;
     }
-    if (hasCollision(
-            cpuPlayer->x, cpuPlayer->y,
-            cpuPlayer->width, cpuPlayer->height,
-            ball->x, ball->y,
-            ball->width, ball->height) &&
-        ball->velocityX > 0)
+    defaults->blocksRemaining = BLOCK_COUNT;
+
+    game = gameDefaults;
+}
+
+/* Set up a new match and clear the screen for it */
+void resetMatch()
+{
+    gameReset();
+    TRACE(TRACE_MATCH_START, game.gameMode, game.ballSpeedTier);
+
+    resetDrawQueue();
+    clearScreen();
+    rasterClearScoreTint();
+
+    if (game.gameMode == GAME_OBSTACLE)
     {
-        bounceOffPaddle(cpuPlayer, ball);
+        clearPendingBlocks();
+        drawBlocks();
     }
 
-    return;
+    schedulerResync();
+}
+
+/* Keep a rectangle clearing from where it is drawn now, not where the restored state last drew it */
+void keepDrawnPosition(rectangle *restored, rectangle *drawn)
+{
+    restored->prevX = drawn->prevX;
+    restored->prevY = drawn->prevY;
+}
+
+/*  Step the match back one frame, returns false when out of history.
+    The score tint, screen flash and camera shake and zoom aren't part of
+    the game state, so they are cancelled rather than rewound.
+*/
+bool rewindMatch()
+{
+    rectangle player = game.player;
+    rectangle cpuPlayer = game.cpuPlayer;
+    rectangle ball = game.ball;
+
+    u32 aliveBefore[BLOCK_WORDS];
+    for (int i = 0; i < BLOCK_WORDS; i++)
+        aliveBefore[i] = game.blockAlive[i];
+
+    if (!rewindPop())
+        return false;
+
+    keepDrawnPosition(&game.player, &player);
+    keepDrawnPosition(&game.cpuPlayer, &cpuPlayer);
+    keepDrawnPosition(&game.ball, &ball);
+
+    if (game.gameMode == GAME_OBSTACLE)
+        markChangedBlocks(aliveBefore);
+
+    rasterClearScoreTint();
+    rasterStopFlash();
+    cameraSettle();
+
+    return true;
 }
 
 int main(void)
 {
+    traceInit();
+
     // Interrupt handlers
     irqInit();
+    schedulerInit();
 
     // Enable Vblank Interrupt, Allow VblankIntrWait
     irqEnable(IRQ_VBLANK);
@@ -246,45 +411,140 @@ int main(void)
     /* Set screen to mode 3 */
     SetMode(MODE_3 | BG2_ON);
 
-    /* Match Variables */
-    int playerScore;
-    int cpuScore;
-    int pauseCounter;
-
-    rectangle player;
-    player.x = 1;
-    player.y = PLAYER_START_Y;
-    player.prevX = player.x;
-    player.prevY = player.y;
-    player.width = PADDLE_WIDTH;
-    player.height = PADDLE_HEIGHT;
-
-    rectangle cpuPlayer;
-    cpuPlayer.x = SCREEN_WIDTH - PADDLE_WIDTH - 1;
-    cpuPlayer.y = PLAYER_START_Y;
-    cpuPlayer.prevX = cpuPlayer.x;
-    cpuPlayer.prevY = cpuPlayer.y;
-    cpuPlayer.width = PADDLE_WIDTH;
-    cpuPlayer.height = PADDLE_HEIGHT;
-
-    rectangle ball;
-    ball.x = BALL_START_X;
-    ball.y = (SCREEN_HEIGHT / 2) - (BALL_SIZE / 2);
-    ball.prevX = ball.x;
-    ball.prevY = ball.y;
-    ball.width = BALL_SIZE;
-    ball.height = BALL_SIZE;
-    ball.velocityX = 2;
-    ball.velocityY = 2;
+    /* Measure drawing costs for the VBlank budget while the screen is still blank */
+    calibrateDrawQueue();
+
+    /* Backdrop gradient behind the playfield */
+    rasterInit();
+    rasterSetGradient(COLOR_RGB(0, 0, 8), CLR_BLACK);
+
+    /* Match state lives in the game arena, see gamestate.h */
+    initGameDefaults();
+    buildBlockGrid();
+
+    int state = STATE_MENU;
+
+    /* Build the menu tree */
+    menuInit(&mainMenu, ASSET_MENU, "MAIN MENU", 0);
+    menuAddItem(&mainMenu, "PLAY", ACTION_PLAY);
+    menuAddItem(&mainMenu, "OPTIONS", ACTION_OPTIONS);
+
+    menuInit(&optionsMenu, ASSET_MENU, "OPTIONS", &mainMenu);
+    modeLabel = menuAddItem(&optionsMenu, "", ACTION_TOGGLE_MODE);
+    speedLabel = menuAddItem(&optionsMenu, "", ACTION_TOGGLE_SPEED);
+    menuAddItem(&optionsMenu, "BACK", ACTION_BACK);
+    updateOptionLabels();
+
+    menuInit(&gameOverMenu, ASSET_WIN, "", 0);
+    menuAddItem(&gameOverMenu, "REMATCH", ACTION_REMATCH);
+    menuAddItem(&gameOverMenu, "MAIN MENU", ACTION_MAIN_MENU);
+
+    /* Title screen until START is pressed */
+    loadScreen(ASSET_TITLE);
+    do
+    {
+        VBlankIntrWait();
+        scanKeys();
+    } while (!(keysDown() & KEY_START));
+
+    menuOpen(&mainMenu);
+
+    /* The title screen doesn't run logic steps, start counting them now */
+    schedulerStart();
 
     /* Main Game Loop */
     while (1)
     {
-        VBlankIntrWait();
+        int steps = schedulerBeginFrame();
+
+        /* Draw last frame's commands while the screen isn't being scanned out */
+        if (scheduler.inVBlank)
+            flushDrawQueue();
+
         scanKeys();
 
-        matchMode(&player, &cpuPlayer, &ball, &playerScore, &cpuScore, &pauseCounter);
+        if (state == STATE_MENU)
+        {
+            switch (menuUpdate(activeMenu))
+            {
+            case ACTION_PLAY:
+            case ACTION_REMATCH:
+                resetMatch();
+                TRACE(TRACE_STATE, state, STATE_MATCH);
+                state = STATE_MATCH;
+                break;
+
+            case ACTION_OPTIONS:
+                menuOpen(&optionsMenu);
+                break;
+
+            case ACTION_TOGGLE_MODE:
+                game.gameMode = (game.gameMode == GAME_CLASSIC) ? GAME_OBSTACLE : GAME_CLASSIC;
+                updateOptionLabels();
+                break;
+
+            case ACTION_TOGGLE_SPEED:
+                game.ballSpeedTier = (game.ballSpeedTier + 1) % BALL_SPEED_TIERS;
+                updateOptionLabels();
+                break;
+
+            case ACTION_BACK:
+                menuOpen(activeMenu->parent);
+                break;
+
+            case ACTION_MAIN_MENU:
+                menuOpen(&mainMenu);
+                break;
+            }
+        }
+        else
+        {
+            /* L + R saves the trace so far, to look at a misbehaving rally */
+            if ((keysDown() & (KEY_L | KEY_R)) && (keysHeld() & (KEY_L | KEY_R)) == (KEY_L | KEY_R))
+                traceExportToSram(scheduler.ticks);
+
+            /* Hold L to rewind, until the match is decided */
+            bool isRewinding = (keysHeld() & (KEY_L | KEY_R)) == KEY_L && !game.isMatchOver;
+
+            /* Logic always runs at 60 Hz, catching up after a slow frame */
+            for (int i = 0; i < steps; i++)
+            {
+                if (isRewinding)
+                {
+                    if (!rewindMatch())
+                        break;
+                    continue;
+                }
+
+                rewindPush();
+                matchMode();
+
+                /* Show the rematch menu once the winner has been on screen for the pause */
+                if (game.isMatchOver && !game.isGamePaused)
+                {
+                    menuSetLabel(&gameOverMenu.title, game.playerScore > game.cpuScore ? " YOU WIN! " : " CPU WINS ");
+                    menuOpen(&gameOverMenu);
+                    TRACE(TRACE_STATE, state, STATE_MENU);
+                    state = STATE_MENU;
+
+                    /* Keep a record of the whole match in the save file */
+                    traceExportToSram(scheduler.ticks);
+                    break;
+                }
+            }
+        }
 
-        /* Reset after completed game */
+        /* Skip rendering if this frame overran */
+        if (schedulerEndFrame())
+        {
+            if (state == STATE_MENU)
+                menuRender(activeMenu);
+            else
+                drawMatch();
+        }
+        else
+        {
+            TRACE(TRACE_FRAME_SKIP, 0, scheduler.catchUpDepth);
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+/*  Retained Mode Menus
+
+    Each menu screen is a small widget tree: a background asset, a title
+    label and a list of item buttons, with a parent screen to go back to.
+    Widgets remember whether they need repainting, so after a screen is
+    opened only the cursor and labels whose text changed are redrawn.
+*/
+
+#define MENU_MAX_ITEMS 4
+#define MENU_LABEL_SIZE 11 // NUM_CHARS_LINE characters and a terminator
+
+enum menuAction
+{
+    ACTION_NONE,
+    ACTION_PLAY,
+    ACTION_OPTIONS,
+    ACTION_TOGGLE_MODE,
+    ACTION_TOGGLE_SPEED,
+    ACTION_BACK,
+    ACTION_REMATCH,
+    ACTION_MAIN_MENU
+};
+
+typedef struct
+{
+    char text[MENU_LABEL_SIZE];
+    int x;
+    int y;
+    int action;
+    bool isDirty;
+} menuWidget;
+
+typedef struct menuScreen
+{
+    int background;
+    menuWidget title;
+    menuWidget items[MENU_MAX_ITEMS];
+    int itemCount;
+    int cursor;
+    int drawnCursor; // -1 when the cursor hasn't been painted
+    struct menuScreen *parent;
+} menuScreen;
+
+menuScreen *activeMenu;
+
+/* Set a widget's text, padded to a full line. Only marks it dirty if it changed. */
+void menuSetLabel(menuWidget *widget, char *text)
+{
+    char padded[MENU_LABEL_SIZE];
+    int i = 0;
+
+    for (; i < NUM_CHARS_LINE && text[i]; i++)
+        padded[i] = text[i];
+    for (; i < NUM_CHARS_LINE; i++)
+        padded[i] = ' ';
+    padded[NUM_CHARS_LINE] = 0;
+
+    for (i = 0; i < NUM_CHARS_LINE; i++)
+    {
+        if (widget->text[i] != padded[i])
+        {
+            for (int j = 0; j <= NUM_CHARS_LINE; j++)
+                widget->text[j] = padded[j];
+
+            widget->isDirty = true;
+            return;
+        }
+    }
+}
+
+void menuInit(menuScreen *screen, int background, char *title, menuScreen *parent)
+{
+    screen->background = background;
+    screen->title.x = MENU_TEXT_X;
+    screen->title.y = MENU_TEXT_Y;
+    screen->title.action = ACTION_NONE;
+    menuSetLabel(&screen->title, title);
+    screen->itemCount = 0;
+    screen->cursor = 0;
+    screen->drawnCursor = -1;
+    screen->parent = parent;
+}
+
+menuWidget *menuAddItem(menuScreen *screen, char *text, int action)
+{
+    menuWidget *item = &screen->items[screen->itemCount];
+
+    item->x = MENU_TEXT_X;
+    item->y = MENU_ITEM_1 + screen->itemCount * LINE_HEIGHT;
+    item->action = action;
+    menuSetLabel(item, text);
+
+    screen->itemCount++;
+    return item;
+}
+
+/* Show menu cursor on current selection, clearing only its old position */
+void setMenuCursor(int previous, int selection)
+{
+    if (previous >= 0)
+    {
+        int y = MENU_ITEM_1 + previous * LINE_HEIGHT;
+        queueClearRegion(MENU_TEXT_X - CHAR_PIX_SIZE, y, MENU_TEXT_X, y + CHAR_PIX_SIZE);
+    }
+
+    queueGlyph(selector[1], MENU_TEXT_X - CHAR_PIX_SIZE, MENU_ITEM_1 + selection * LINE_HEIGHT, 1);
+}
+
+/* Switch screens. The background is the only full redraw. */
+void menuOpen(menuScreen *screen)
+{
+    activeMenu = screen;
+
+    resetDrawQueue();
+    loadScreen(screen->background);
+
+    screen->title.isDirty = true;
+    for (int i = 0; i < screen->itemCount; i++)
+        screen->items[i].isDirty = true;
+
+    screen->drawnCursor = -1;
+}
+
+/* Handle input, returns the action of the item picked (if any) */
+int menuUpdate(menuScreen *screen)
+{
+    int keys_pressed = keysDown();
+
+    if (keys_pressed & KEY_UP)
+        screen->cursor = (screen->cursor + screen->itemCount - 1) % screen->itemCount;
+    if (keys_pressed & KEY_DOWN)
+        screen->cursor = (screen->cursor + 1) % screen->itemCount;
+
+    if (keys_pressed & (KEY_A | KEY_START))
+        return screen->items[screen->cursor].action;
+    if ((keys_pressed & KEY_B) && screen->parent)
+        return ACTION_BACK;
+
+    return ACTION_NONE;
+}
+
+void menuRenderWidget(menuWidget *widget)
+{
+    if (!widget->isDirty)
+        return;
+
+    queueText(widget->text, widget->x, widget->y);
+    widget->isDirty = false;
+}
+
+/* Queue repaints for whatever changed since the last render */
+void menuRender(menuScreen *screen)
+{
+    menuRenderWidget(&screen->title);
+
+    for (int i = 0; i < screen->itemCount; i++)
+        menuRenderWidget(&screen->items[i]);
+
+    if (screen->cursor != screen->drawnCursor)
+    {
+        setMenuCursor(screen->drawnCursor, screen->cursor);
+        screen->drawnCursor = screen->cursor;
+    }
+}
@@ -0,0 +1,166 @@
+/*  Raster Effects
+
+    Mode 3 has no palette for BG2, but the backdrop colour (palette entry 0)
+    can be alpha blended under it. Black playfield pixels then show the
+    backdrop, so changing the backdrop per scanline with HBlank DMA paints
+    a gradient behind the game without touching the framebuffer.
+
+    The gradient is worked out when it's set, outside the interrupt. The
+    VBlank handler only copies it into the scanline table when it changes
+    and patches the few tinted lines when the score tint changes, so the
+    steady state costs a few register writes.
+*/
+
+#define MEM_PAL 0x05000000
+
+/* Blend control: BG2 on top, backdrop underneath */
+#define BLEND_TOP_BG2 0x0004
+#define BLEND_TOP_BACKDROP 0x0020
+#define BLEND_ALPHA 0x0040
+#define BLEND_BRIGHTEN 0x0080
+#define BLEND_BOTTOM_BACKDROP 0x2000
+
+#define BLEND_WEIGHTS(top, bottom) ((top) | ((bottom) << 8))
+
+/* Colour channels of a 15 bit BGR colour */
+#define COLOR_R(color) ((color) & 0x1F)
+#define COLOR_G(color) (((color) >> 5) & 0x1F)
+#define COLOR_B(color) (((color) >> 10) & 0x1F)
+#define COLOR_RGB(r, g, b) ((r) | ((g) << 5) | ((b) << 10))
+
+const int SCORE_TINT_HEIGHT = 16;
+
+typedef struct
+{
+    /* Backdrop colour for each scanline, entry 0 is set during VBlank and
+       the DMA copies entry n + 1 in the HBlank after line n. */
+    u16 backdrop[SCREEN_HEIGHT + 1] __attribute__((aligned(4)));
+
+    /* Gradient without the tint, built by rasterSetGradient() */
+    u16 gradient[SCREEN_HEIGHT] __attribute__((aligned(4)));
+
+    u16 scoreTint;
+    bool scoreTintOn;
+    volatile bool isGradientDirty;
+    volatile bool isTintDirty;
+
+    int flashFrames;
+    int flashLength;
+} rasterEffects;
+
+rasterEffects raster;
+
+/* Vertical colour gradient behind the playfield */
+void rasterSetGradient(int topColor, int bottomColor)
+{
+    /* Step each channel in 16.16 fixed point, three divides in total */
+    int r = COLOR_R(topColor) << 16;
+    int g = COLOR_G(topColor) << 16;
+    int b = COLOR_B(topColor) << 16;
+    int stepR = ((COLOR_R(bottomColor) - COLOR_R(topColor)) << 16) / (SCREEN_HEIGHT - 1);
+    int stepG = ((COLOR_G(bottomColor) - COLOR_G(topColor)) << 16) / (SCREEN_HEIGHT - 1);
+    int stepB = ((COLOR_B(bottomColor) - COLOR_B(topColor)) << 16) / (SCREEN_HEIGHT - 1);
+
+    for (int line = 0; line < SCREEN_HEIGHT; line++)
+    {
+        raster.gradient[line] = COLOR_RGB(r >> 16, g >> 16, b >> 16);
+
+        r += stepR;
+        g += stepG;
+        b += stepB;
+    }
+
+    raster.isGradientDirty = true;
+}
+
+/* Tint the scanlines behind the scores */
+void rasterSetScoreTint(int color)
+{
+    if (raster.scoreTintOn && raster.scoreTint == color)
+        return;
+
+    raster.scoreTint = color;
+    raster.scoreTintOn = true;
+    raster.isTintDirty = true;
+}
+
+void rasterClearScoreTint()
+{
+    if (!raster.scoreTintOn)
+        return;
+
+    raster.scoreTintOn = false;
+    raster.isTintDirty = true;
+}
+
+/* Flash the whole screen white, fading out over a number of frames */
+void rasterFlash(int frames)
+{
+    raster.flashLength = frames;
+    raster.flashFrames = frames;
+}
+
+/* Finish a flash on the next VBlank */
+void rasterStopFlash()
+{
+    if (raster.flashFrames > 1)
+        raster.flashFrames = 1;
+}
+
+void rasterInit()
+{
+    REG_BLDCNT = BLEND_TOP_BG2 | BLEND_ALPHA | BLEND_BOTTOM_BACKDROP;
+    REG_BLDALPHA = BLEND_WEIGHTS(16, 16);
+
+    rasterSetGradient(CLR_BLACK, CLR_BLACK);
+}
+
+/* Write the tint, or the gradient underneath it, into the score lines */
+void patchScoreTint()
+{
+    for (int line = SCORE_Y; line < SCORE_Y + SCORE_TINT_HEIGHT; line++)
+    {
+        raster.backdrop[line] = raster.scoreTintOn ? raster.scoreTint : raster.gradient[line];
+    }
+
+    raster.backdrop[SCREEN_HEIGHT] = raster.backdrop[0];
+}
+
+/* Call once per VBlank, before line 0 is drawn */
+void rasterVBlank()
+{
+    if (raster.isGradientDirty)
+    {
+        raster.isGradientDirty = false;
+        CpuFastSet(raster.gradient, raster.backdrop, SCREEN_HEIGHT / 2);
+
+        /* The copy overwrote the tinted lines */
+        raster.isTintDirty = true;
+    }
+
+    if (raster.isTintDirty)
+    {
+        raster.isTintDirty = false;
+        patchScoreTint();
+    }
+
+    /* Restart the HBlank DMA at the top of the table */
+    REG_DMA0CNT = 0;
+    ((u16 *)MEM_PAL)[0] = raster.backdrop[0];
+    REG_DMA0SAD = (u32)&raster.backdrop[1];
+    REG_DMA0DAD = MEM_PAL;
+    REG_DMA0CNT = 1 | DMA_DST_RELOAD | DMA_SRC_INC | DMA_REPEAT | DMA16 | DMA_HBLANK | DMA_ENABLE;
+
+    /* Screen flash uses brightness fade instead of the backdrop blend */
+    if (raster.flashFrames > 0)
+    {
+        REG_BLDCNT = BLEND_TOP_BG2 | BLEND_TOP_BACKDROP | BLEND_BRIGHTEN;
+        REG_BLDY = 16 * raster.flashFrames / raster.flashLength;
+        raster.flashFrames--;
+
+        if (raster.flashFrames == 0)
+        {
+            REG_BLDCNT = BLEND_TOP_BG2 | BLEND_ALPHA | BLEND_BOTTOM_BACKDROP;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*  Fixed Timestep Scheduler
+
+    The VBlank interrupt is the 60 Hz clock. Game logic runs once for every
+    VBlank that has passed, however long rendering took, so gameplay speed
+    stays constant. If a frame overruns into the next VBlank its render is
+    skipped and the following frame runs extra logic steps to catch up.
+*/
+
+/* Most logic steps run in one frame, anything beyond this is dropped */
+const int MAX_CATCH_UP = 4;
+
+typedef struct
+{
+    volatile u32 ticks;   // VBlanks since boot, counted by the interrupt
+    u32 simulatedFrames;  // Logic steps run so far
+    u32 frameStartTick;
+    bool inVBlank;        // Frame started right after waiting for VBlank
+    volatile bool isRunning; // Main loop has started, so lag is meaningful
+
+    /* Counters */
+    int catchUpDepth;     // Logic steps run this frame
+    int maxCatchUpDepth;
+    int skippedFrames;    // Renders skipped because the frame overran
+    int droppedSteps;     // Steps lost to the MAX_CATCH_UP limit
+} frameScheduler;
+
+frameScheduler scheduler;
+
+/* VBlank interrupt: count the tick, restart the scanline effects and upload the camera */
+void onVBlank()
+{
+    scheduler.ticks++;
+    rasterVBlank();
+
+    /* Note when the main loop has fallen more than a frame behind */
+    int lag = scheduler.ticks - scheduler.simulatedFrames;
+    if (scheduler.isRunning && lag > 1)
+        traceWrite(TRACE_IRQ, scheduler.ticks, TRACE_VBLANK_LATE, 0, lag);
+
+    cameraVBlank();
+}
+
+void schedulerInit()
+{
+    irqSet(IRQ_VBLANK, onVBlank);
+    scheduler.simulatedFrames = scheduler.ticks;
+}
+
+/* Forget any ticks missed during a long blocking load or wait */
+void schedulerResync()
+{
+    scheduler.simulatedFrames = scheduler.ticks;
+    scheduler.frameStartTick = scheduler.ticks;
+}
+
+/* Start counting logic steps, call right before the main loop */
+void schedulerStart()
+{
+    schedulerResync();
+    scheduler.isRunning = true;
+}
+
+/*  Start a frame, waiting for VBlank if logic is caught up.
+    Returns how many logic steps to run.
+*/
+int schedulerBeginFrame()
+{
+    scheduler.inVBlank = (scheduler.ticks == scheduler.simulatedFrames);
+    if (scheduler.inVBlank)
+    {
+        VBlankIntrWait();
+    }
+
+    u32 now = scheduler.ticks;
+    int steps = now - scheduler.simulatedFrames;
+
+    if (steps > MAX_CATCH_UP)
+    {
+        scheduler.droppedSteps += steps - MAX_CATCH_UP;
+        steps = MAX_CATCH_UP;
+    }
+
+    scheduler.simulatedFrames = now;
+    scheduler.frameStartTick = now;
+
+    scheduler.catchUpDepth = steps;
+    if (steps > scheduler.maxCatchUpDepth)
+        scheduler.maxCatchUpDepth = steps;
+
+    return steps;
+}
+
+/*  Finish the logic for a frame. Returns false if it ran past the next
+    VBlank, in which case this frame's render should be skipped.
+*/
+bool schedulerEndFrame()
+{
+    if (scheduler.ticks != scheduler.frameStartTick)
+    {
+        scheduler.skippedFrames++;
+        return false;
+    }
+
+    return true;
+}
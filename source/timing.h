@@ -0,0 +1,41 @@
+/*  Cycle Timer
+
+    Timer 2 counts CPU cycles and timer 3 counts its overflows, giving a
+    32 bit cycle counter for measuring how long something really takes.
+    Only one measurement can run at a time.
+*/
+
+void startCycleTimer()
+{
+    REG_TM2CNT_H = 0;
+    REG_TM3CNT_H = 0;
+    REG_TM2CNT_L = 0;
+    REG_TM3CNT_L = 0;
+    REG_TM3CNT_H = TIMER_COUNT | TIMER_START;
+    REG_TM2CNT_H = TIMER_START;
+}
+
+/* Cycles since startCycleTimer, safe to call while it's running */
+u32 readCycleTimer()
+{
+    u32 high = REG_TM3CNT_L;
+    u32 low = REG_TM2CNT_L;
+
+    /* Timer 2 overflowed between the reads, read it again */
+    if (REG_TM3CNT_L != high)
+    {
+        high = REG_TM3CNT_L;
+        low = REG_TM2CNT_L;
+    }
+
+    return (high << 16) | low;
+}
+
+u32 stopCycleTimer()
+{
+    REG_TM2CNT_H = 0;
+    u32 cycles = (REG_TM3CNT_L << 16) | REG_TM2CNT_L;
+    REG_TM3CNT_H = 0;
+
+    return cycles;
+}
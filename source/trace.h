@@ -0,0 +1,118 @@
+/*  Event Trace
+
+    A flight recorder of what happened during a match. Records are fixed
+    size (frame, event id, two args) and go into ring buffers that keep
+    the most recent TRACE_RING_SIZE events.
+
+    Each ring has a single producer: the main loop writes to one and the
+    VBlank interrupt to the other, so neither can tear the other's record
+    and no locking is needed. A record is filled in before the head is
+    advanced past it.
+
+    The trace lives in EWRAM behind a "PTRC" header so it can be found in
+    an emulator memory dump, and traceExportToSram() copies it to the save
+    file. tools/trace2json.py turns either into a Chrome trace timeline.
+*/
+
+#define TRACE_VERSION 1
+#define TRACE_RING_SIZE 512 // Must be a power of two
+#define MEM_SRAM 0x0E000000
+
+enum traceProducer
+{
+    TRACE_MAIN,
+    TRACE_IRQ,
+    TRACE_PRODUCERS
+};
+
+/* Keep in sync with EVENT_NAMES in tools/trace2json.py */
+enum traceEvent
+{
+    TRACE_STATE,         // from, to
+    TRACE_MATCH_START,   // game mode, ball speed tier
+    TRACE_SCORE,         // is human, new score
+    TRACE_BOUNCE_PADDLE, // is human, new velocityY
+    TRACE_BOUNCE_WALL,   // is floor, velocityX
+    TRACE_BLOCK_HIT,     // 0, block index
+    TRACE_FRAME_SKIP,    // 0, catch up depth
+    TRACE_VBLANK_LATE,   // 0, frames behind
+    TRACE_EXPORT,        // 0, 0
+    TRACE_ASSET_LOAD,    // asset, load cycles / 256
+    TRACE_ASSET_SIZE     // asset, compressed size as a percentage of raw
+};
+
+typedef struct
+{
+    u32 frame;
+    u8 event;
+    u8 arg0;
+    u16 arg1;
+} traceRecord;
+
+typedef struct
+{
+    volatile u32 head; // Total records written, the next slot is head % TRACE_RING_SIZE
+    traceRecord records[TRACE_RING_SIZE];
+} traceRing;
+
+typedef struct
+{
+    char magic[4];
+    u16 version;
+    u16 recordSize;
+    u16 ringSize;
+    u16 ringCount;
+    traceRing rings[TRACE_PRODUCERS];
+} traceBuffer;
+
+EWRAM_BSS traceBuffer traceLog;
+
+/* Tells emulators the cartridge has SRAM for the exported trace */
+const char saveType[] __attribute__((aligned(4), used)) = "SRAM_V113";
+
+void traceInit()
+{
+    traceLog.magic[0] = 'P';
+    traceLog.magic[1] = 'T';
+    traceLog.magic[2] = 'R';
+    traceLog.magic[3] = 'C';
+    traceLog.version = TRACE_VERSION;
+    traceLog.recordSize = sizeof(traceRecord);
+    traceLog.ringSize = TRACE_RING_SIZE;
+    traceLog.ringCount = TRACE_PRODUCERS;
+}
+
+/* Append a record, only ever call with the producer you are */
+void traceWrite(int producer, u32 frame, int event, int arg0, int arg1)
+{
+    traceRing *ring = &traceLog.rings[producer];
+    u32 head = ring->head;
+    traceRecord *record = &ring->records[head & (TRACE_RING_SIZE - 1)];
+
+    record->frame = frame;
+    record->event = event;
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+
+    /* Publish after the record is complete */
+    ring->head = head + 1;
+}
+
+/* Record an event from the main loop, stamped with the current frame */
+#define TRACE(event, arg0, arg1) traceWrite(TRACE_MAIN, scheduler.ticks, (event), (arg0), (arg1))
+
+/*  Copy the trace into SRAM (8 bit bus, so a byte at a time). Events
+    the interrupt writes during the copy may be missing or half copied.
+*/
+void traceExportToSram(u32 frame)
+{
+    traceWrite(TRACE_MAIN, frame, TRACE_EXPORT, 0, 0);
+
+    u8 *source = (u8 *)&traceLog;
+    vu8 *sram = (vu8 *)MEM_SRAM;
+
+    for (unsigned int i = 0; i < sizeof(traceBuffer); i++)
+    {
+        sram[i] = source[i];
+    }
+}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Convert a Pong event trace into a Chrome trace JSON timeline.
+
+The input can be the game's save file (the trace is exported to SRAM when
+a match ends, or when L + R are pressed during a match) or a raw emulator
+memory dump containing EWRAM. The trace is found by its "PTRC" header.
+
+Usage:
+    python3 tools/trace2json.py Pong-Homebrew-GBA.sav trace.json
+
+Open the output in chrome://tracing or https://ui.perfetto.dev
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"PTRC"
+SUPPORTED_VERSION = 1
+HEADER = struct.Struct("<4sHHHH")
+HEAD = struct.Struct("<I")
+RECORD = struct.Struct("<IBBH")
+
+# GBA refresh rate is 59.7275 Hz
+FRAME_US = 1000000 / 59.7275
+
+# Keep in sync with enum traceEvent in source/trace.h
+EVENT_NAMES = [
+    "state",
+    "match start",
+    "score",
+    "paddle bounce",
+    "wall bounce",
+    "block hit",
+    "frame skip",
+    "vblank late",
+    "export",
+    "asset load",
+    "asset size",
+]
+
+PRODUCER_NAMES = ["main", "irq"]
+
+
+def signed16(value):
+    return value - 0x10000 if value & 0x8000 else value
+
+
+def read_trace(data):
+    offset = data.find(MAGIC)
+    if offset < 0:
+        raise ValueError("no trace header found")
+
+    magic, version, record_size, ring_size, ring_count = HEADER.unpack_from(data, offset)
+    if version != SUPPORTED_VERSION or record_size != RECORD.size:
+        raise ValueError("unsupported trace version %d, record size %d" % (version, record_size))
+
+    records = []
+    offset += HEADER.size
+
+    for producer in range(ring_count):
+        (head,) = HEAD.unpack_from(data, offset)
+        base = offset + HEAD.size
+
+        # The ring keeps the newest ring_size records, oldest first from head
+        count = min(head, ring_size)
+        for n in range(head - count, head):
+            slot = base + (n % ring_size) * record_size
+            frame, event, arg0, arg1 = RECORD.unpack_from(data, slot)
+            records.append((frame, producer, n, event, arg0, signed16(arg1)))
+
+        offset = base + ring_size * record_size
+
+    records.sort()
+    return records
+
+
+def to_chrome_trace(records):
+    events = []
+    scores = [0, 0]
+
+    for producer, name in enumerate(PRODUCER_NAMES):
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": producer,
+                       "args": {"name": name}})
+
+    for frame, producer, _, event, arg0, arg1 in records:
+        name = EVENT_NAMES[event] if event < len(EVENT_NAMES) else "event %d" % event
+        ts = frame * FRAME_US
+
+        events.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": 0, "tid": producer,
+                       "args": {"frame": frame, "arg0": arg0, "arg1": arg1}})
+
+        # Scores as a counter track
+        if name == "match start":
+            scores = [0, 0]
+        elif name == "score":
+            scores[0 if arg0 else 1] = arg1
+        else:
+            continue
+
+        events.append({"name": "score", "ph": "C", "ts": ts, "pid": 0,
+                       "args": {"player": scores[0], "cpu": scores[1]}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+
+    with open(sys.argv[1], "rb") as f:
+        records = read_trace(f.read())
+
+    with open(sys.argv[2], "w") as f:
+        json.dump(to_chrome_trace(records), f, indent=1)
+
+    print("%d events written to %s" % (len(records), sys.argv[2]))
+
+
+if __name__ == "__main__":
+    main()